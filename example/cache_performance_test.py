@@ -43,7 +43,7 @@ class CachePerformanceTester:
             print(f"Progress: {progress:.1f}%")
 
         print(f"Memory Usage: {metrics.memory_usage / (1024 * 1024):.2f} MB")
-        print(f">> String Memory: {metrics.string_memory / (1024 * 1024):.2f} MB "
+        print(f">> String Heap Buffers: {metrics.string_memory / (1024 * 1024):.2f} MB "
               f"({(metrics.string_memory / metrics.memory_usage * 100):.1f}% of total)")
         print(f"Average Item Size: {metrics.average_item_size / 1024:.2f} KB")
         print(f"Hit Rate: {metrics.hit_rate:.2f}%")
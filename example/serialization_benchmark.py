@@ -0,0 +1,99 @@
+import os
+import resource
+import subprocess
+import sys
+import time
+from cache_system import LRUCache, CacheItem
+
+
+def peak_rss_mb():
+    """Peak resident set size of this process in MB (ru_maxrss is in KB on Linux)."""
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+
+
+def current_rss_mb():
+    """Current resident set size of this process in MB."""
+    with open("/proc/self/statm") as statm:
+        pages = int(statm.read().split()[1])
+    return pages * os.sysconf("SC_PAGE_SIZE") / (1024 * 1024)
+
+
+def create_test_item(id_num):
+    """Create a cache item shaped like the ones in cache_performance_test.py."""
+    return CacheItem(
+        id_num,
+        f"Faculty_{id_num % 5}",
+        f"Course_{id_num % 10}",
+        f"Title_{id_num}",
+        f"Test description for item {id_num} " * 10,
+        id_num % 1000,
+        f"t.me/group_{id_num}",
+        1000 + id_num % 9000
+    )
+
+
+def report(phase, num_entries, elapsed, baseline_rss, cache):
+    """Print throughput and how far the phase pushed peak RSS past its baseline."""
+    metrics = cache.get_metrics()
+    peak = peak_rss_mb()
+
+    print(f"\n{phase}:")
+    print(f"Entries: {num_entries:,}")
+    print(f"Time: {elapsed:.2f} s ({num_entries / elapsed:,.0f} entries/s)")
+    print(f"Cache Memory: {metrics.memory_usage / (1024 * 1024):.2f} MB")
+    print(f"RSS before: {baseline_rss:.2f} MB, peak: {peak:.2f} MB "
+          f"(+{peak - baseline_rss:.2f} MB)")
+
+
+def run_save(filename, num_entries):
+    cache = LRUCache(num_entries)
+    for i in range(num_entries):
+        cache.put(i, create_test_item(i))
+
+    baseline_rss = current_rss_mb()
+    start = time.perf_counter()
+    cache.save_to_file(filename)
+    elapsed = time.perf_counter() - start
+
+    report("Save", num_entries, elapsed, baseline_rss, cache)
+    print(f"File Size: {os.path.getsize(filename) / (1024 * 1024):.2f} MB")
+
+
+def run_load(filename, num_entries):
+    cache = LRUCache(num_entries)
+
+    baseline_rss = current_rss_mb()
+    start = time.perf_counter()
+    cache.load_from_file(filename)
+    elapsed = time.perf_counter() - start
+
+    report("Load", num_entries, elapsed, baseline_rss, cache)
+    print("Peak RSS over the loaded cache is the serialization overhead.")
+
+
+def main():
+    """Run each phase in a fresh process so ru_maxrss reflects that phase alone."""
+    if len(sys.argv) == 4:
+        phase, filename, num_entries = sys.argv[1], sys.argv[2], int(sys.argv[3])
+        {"save": run_save, "load": run_load}[phase](filename, num_entries)
+        return
+
+    num_entries = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+    filename = "serialization_benchmark.json"
+
+    print("=" * 40)
+    print("TEST: Streaming JSON Serialization")
+    print(f"Entries: {num_entries:,}")
+    print("=" * 40)
+
+    try:
+        for phase in ("save", "load"):
+            subprocess.run([sys.executable, __file__, phase, filename, str(num_entries)],
+                           check=True)
+    finally:
+        if os.path.exists(filename):
+            os.remove(filename)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <ostream>
+#include "cache_item.hpp"
+
+// Writes the `[{"key": ..., "value": {...}}, ...]` cache file format one
+// entry at a time, so only a single entry is ever held as a JSON value.
+class CacheJsonWriter {
+public:
+    explicit CacheJsonWriter(std::ostream& out);
+
+    void write(int key, const CacheItem& item);
+    void finish();
+
+private:
+    std::ostream& out_;
+    bool first_ = true;
+    bool finished_ = false;
+};
+
+// Parses the cache file format with nlohmann's SAX interface and hands each
+// entry to `on_entry` as soon as it is complete, without building a DOM.
+// Throws std::runtime_error on malformed input or missing fields.
+void read_cache_json(std::istream& in,
+                     const std::function<void(int key, CacheItem&& item)>& on_entry);
@@ -27,19 +27,38 @@ private:
     struct CacheEntry {
         CacheItem item;
         std::chrono::steady_clock::time_point last_access;
+        // Footprint added to the totals on insertion, released verbatim on erase.
+        size_t memory_size = 0;
+        size_t string_memory = 0;
+    };
+
+    using LruList = std::list<CacheEntry>;
+    using CacheMap = std::unordered_map<int, std::pair<LruList::iterator, CacheEntry>>;
+
+    // Running footprint of the entries held by one CacheMap/LruList pair.
+    struct EntryTotals {
+        size_t memory = 0;
+        size_t string_memory = 0;
     };
 
     void put_internal(int key, CacheItem value);
-    void evict_if_needed();
-    size_t calculate_item_memory_size(const CacheItem& item) const;
+    void put_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                   int key, CacheItem value) const;
+    void insert_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                      int key, CacheItem value) const;
+    void erase_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                     CacheMap::iterator it) const;
+    void evict_if_needed(CacheMap& map, LruList& list, EntryTotals& totals) const;
+    size_t calculate_item_memory_size(const CacheMap::value_type& node) const;
     size_t calculate_string_memory(const CacheItem& item) const;
-    void update_metrics_for_item(const CacheItem& item, bool adding);
-    size_t calculate_actual_memory_usage() const;
+    size_t calculate_bucket_memory() const;
+    void sync_metrics();
     void validate_metrics();
 
     mutable std::mutex mutex_;
     const size_t capacity_;
-    std::unordered_map<int, std::pair<typename std::list<CacheEntry>::iterator, CacheEntry>> cache_;
-    std::list<CacheEntry> lru_list_;
+    CacheMap cache_;
+    LruList lru_list_;
+    EntryTotals totals_;
     CacheMetrics metrics_;
 };
@@ -43,8 +43,11 @@ public:
 
     double get_avg_read_time() const;
     double get_avg_write_time() const;
+    // Heap bytes held by the cache: entry nodes, string buffers and buckets.
     size_t get_memory_usage() const;
     size_t get_peak_memory_usage() const;
+    // Heap string buffers only, counted for both stored copies of each item;
+    // short strings kept inline in std::string are part of the node bytes.
     size_t get_string_memory() const;
     size_t get_item_count() const;
     double get_hit_rate() const;
@@ -0,0 +1,210 @@
+#include "cache/json_stream.hpp"
+#include <stdexcept>
+#include <string>
+
+CacheJsonWriter::CacheJsonWriter(std::ostream& out) : out_(out) {
+    out_ << "[";
+}
+
+void CacheJsonWriter::write(int key, const CacheItem& item) {
+    nlohmann::json entry = {
+        {"key", key},
+        {"value", item.to_json()}
+    };
+
+    out_ << (first_ ? "\n    " : ",\n    ") << entry.dump();
+    first_ = false;
+}
+
+void CacheJsonWriter::finish() {
+    if (!finished_) {
+        out_ << (first_ ? "]\n" : "\n]\n");
+        finished_ = true;
+    }
+}
+
+namespace {
+
+class CacheEntryHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    using Callback = std::function<void(int, CacheItem&&)>;
+
+    explicit CacheEntryHandler(const Callback& on_entry) : on_entry_(on_entry) {}
+
+    bool null() override { return store_other(); }
+    bool boolean(bool) override { return store_other(); }
+    bool number_integer(number_integer_t val) override { return store_int(val); }
+    bool number_unsigned(number_unsigned_t val) override { return store_int(val); }
+    bool number_float(number_float_t val, const string_t&) override { return store_int(val); }
+    bool binary(binary_t&) override { return store_other(); }
+
+    bool string(string_t& val) override {
+        if (skip_depth_ > 0 || depth_ != kItemDepth) {
+            return store_other();
+        }
+
+        // Copied rather than moved: the stored string is sized exactly and
+        // the lexer keeps reusing its token buffer.
+        switch (field_) {
+            case Field::Faculty: item_.faculty = val; break;
+            case Field::Course: item_.course = val; break;
+            case Field::Title: item_.title = val; break;
+            case Field::Description: item_.description = val; break;
+            case Field::TelegramGroupLink: item_.telegramGroupLink = val; break;
+            default: return store_other();
+        }
+        seen_ |= field_bit(field_);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (depth_ == 0) {
+            throw std::runtime_error("expected an array of cache entries");
+        }
+        if (skip_depth_ > 0 || depth_ == kItemDepth ||
+            (depth_ == kEntryDepth && field_ != Field::Value)) {
+            return start_skipped();
+        }
+        if (depth_ == kArrayDepth) {
+            key_ = 0;
+            item_ = CacheItem{};
+            seen_ = 0;
+        }
+        field_ = Field::Other;
+        ++depth_;
+        return true;
+    }
+
+    bool end_object() override {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        --depth_;
+        if (depth_ == kArrayDepth) {
+            if (seen_ != kAllFields) {
+                throw std::runtime_error("cache entry is missing required fields");
+            }
+            on_entry_(key_, std::move(item_));
+        }
+        field_ = Field::Other;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (depth_ != 0) {
+            return start_skipped();
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool end_array() override {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        --depth_;
+        field_ = Field::Other;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        field_ = Field::Other;
+        if (depth_ == kEntryDepth) {
+            if (val == "key") field_ = Field::Key;
+            else if (val == "value") field_ = Field::Value;
+        } else if (depth_ == kItemDepth) {
+            if (val == "id") field_ = Field::Id;
+            else if (val == "faculty") field_ = Field::Faculty;
+            else if (val == "course") field_ = Field::Course;
+            else if (val == "title") field_ = Field::Title;
+            else if (val == "description") field_ = Field::Description;
+            else if (val == "votesCount") field_ = Field::VotesCount;
+            else if (val == "telegramGroupLink") field_ = Field::TelegramGroupLink;
+            else if (val == "userId") field_ = Field::UserId;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception& ex) override {
+        throw std::runtime_error(ex.what());
+    }
+
+private:
+    enum class Field {
+        Other, Key, Value, Id, Faculty, Course, Title,
+        Description, VotesCount, TelegramGroupLink, UserId
+    };
+
+    static constexpr int kArrayDepth = 1;
+    static constexpr int kEntryDepth = 2;
+    static constexpr int kItemDepth = 3;
+    // Bits of every field from Key to UserId except Value.
+    static constexpr unsigned kAllFields = 0x7FA;
+
+    static unsigned field_bit(Field field) {
+        return 1u << static_cast<unsigned>(field);
+    }
+
+    template <typename T>
+    bool store_int(T val) {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        int value = static_cast<int>(val);
+        if (depth_ == kEntryDepth && field_ == Field::Key) {
+            key_ = value;
+        } else if (depth_ == kItemDepth && field_ == Field::Id) {
+            item_.id = value;
+        } else if (depth_ == kItemDepth && field_ == Field::VotesCount) {
+            item_.votesCount = value;
+        } else if (depth_ == kItemDepth && field_ == Field::UserId) {
+            item_.userId = value;
+        } else {
+            return store_other();
+        }
+        seen_ |= field_bit(field_);
+        return true;
+    }
+
+    // Values of unknown fields are ignored; anything else in a known field,
+    // or a non-object where an entry is expected, is a format error.
+    bool store_other() {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        if (depth_ < kEntryDepth || field_ != Field::Other) {
+            throw std::runtime_error("unexpected value in cache entry");
+        }
+        return true;
+    }
+
+    bool start_skipped() {
+        if (skip_depth_ == 0) {
+            store_other();
+        }
+        ++skip_depth_;
+        return true;
+    }
+
+    const Callback& on_entry_;
+    int depth_ = 0;
+    int skip_depth_ = 0;
+    Field field_ = Field::Other;
+    int key_ = 0;
+    CacheItem item_{};
+    unsigned seen_ = 0;
+};
+
+}  // namespace
+
+void read_cache_json(std::istream& in,
+                     const std::function<void(int key, CacheItem&& item)>& on_entry) {
+    CacheEntryHandler handler(on_entry);
+    nlohmann::json::sax_parse(in, &handler);
+}
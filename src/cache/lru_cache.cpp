@@ -1,9 +1,12 @@
 #include "cache/lru_cache.hpp"
+#include "cache/json_stream.hpp"
+#include <algorithm>
 #include <fstream>
-#include <nlohmann/json.hpp>
+#include <functional>
 
 LRUCache::LRUCache(size_t capacity) : capacity_(capacity) {
     cache_.reserve(capacity);
+    sync_metrics();
 }
 
 std::experimental::optional<CacheItem> LRUCache::get(int key) {
@@ -31,147 +34,145 @@ std::experimental::optional<CacheItem> LRUCache::get(int key) {
     return entry.item;
 }
 
-size_t LRUCache::calculate_item_memory_size(const CacheItem& item) const {
-    size_t string_content =
-        item.faculty.size() * sizeof(char) +
-        item.course.size() * sizeof(char) +
-        item.title.size() * sizeof(char) +
-        item.description.size() * sizeof(char) +
-        item.telegramGroupLink.size() * sizeof(char);
-
-    size_t string_capacity_overhead =
-        (item.faculty.capacity() - item.faculty.size()) * sizeof(char) +
-        (item.course.capacity() - item.course.size()) * sizeof(char) +
-        (item.title.capacity() - item.title.size()) * sizeof(char) +
-        (item.description.capacity() - item.description.size()) * sizeof(char) +
-        (item.telegramGroupLink.capacity() - item.telegramGroupLink.size()) * sizeof(char);
-
-    constexpr size_t string_obj_overhead = sizeof(std::string);
-    size_t total_string_overhead = string_obj_overhead * 5;
-
-    constexpr size_t base_size =
-        sizeof(CacheItem) +
-        sizeof(std::pair<typename std::list<CacheEntry>::iterator, CacheEntry>) +
-        sizeof(CacheEntry);
-
-    return base_size + string_content + string_capacity_overhead + total_string_overhead;
+namespace {
+
+// Bytes a heap block of `n` requested bytes really occupies under glibc
+// malloc: an 8-byte chunk header, 16-byte rounding and a 32-byte minimum.
+// Other allocators round differently, so elsewhere this is an estimate.
+size_t heap_allocation_size(size_t n) {
+    constexpr size_t header = sizeof(size_t);
+    constexpr size_t alignment = 2 * sizeof(size_t);
+    constexpr size_t min_chunk = 4 * sizeof(size_t);
+    size_t chunk = (n + header + alignment - 1) & ~(alignment - 1);
+    return std::max(chunk, min_chunk);
 }
 
+size_t string_heap_size(const std::string& s) {
+    const char* data = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    std::less<const char*> before;
+    if (!before(data, self) && before(data, self + sizeof(s))) {
+        return 0;  // stored in the short-string buffer
+    }
+    return heap_allocation_size(s.capacity() + 1);
+}
+
+}  // namespace
+
+size_t LRUCache::calculate_item_memory_size(const CacheMap::value_type& node) const {
+    // Node layouts as allocated by libstdc++: the list node carries two links,
+    // the hash node one link and no cached hash for int keys. Together with
+    // heap_allocation_size this is byte-exact only on libstdc++ over glibc
+    // malloc; with libc++ or another allocator memory_usage is an estimate.
+    struct ListNode {
+        void* next;
+        void* prev;
+        CacheEntry entry;
+    };
+    struct MapNode {
+        void* next;
+        CacheMap::value_type value;
+    };
+
+    return heap_allocation_size(sizeof(ListNode)) +
+           heap_allocation_size(sizeof(MapNode)) +
+           calculate_string_memory(node.second.first->item) +
+           calculate_string_memory(node.second.second.item);
+}
+
+// Heap buffers owned by one copy of the item. Short strings live inside the
+// std::string object and are already covered by the node sizes, so they add
+// nothing here; callers sum both stored copies into string_memory.
 size_t LRUCache::calculate_string_memory(const CacheItem& item) const {
-    return item.faculty.capacity() * sizeof(char) +
-           item.course.capacity() * sizeof(char) +
-           item.title.capacity() * sizeof(char) +
-           item.description.capacity() * sizeof(char) +
-           item.telegramGroupLink.capacity() * sizeof(char);
+    return string_heap_size(item.faculty) +
+           string_heap_size(item.course) +
+           string_heap_size(item.title) +
+           string_heap_size(item.description) +
+           string_heap_size(item.telegramGroupLink);
 }
 
-void LRUCache::update_metrics_for_item(const CacheItem& item, bool adding) {
-    size_t item_size = calculate_item_memory_size(item);
-    size_t string_mem = calculate_string_memory(item);
-
-    if (adding) {
-        metrics_.update_memory_usage(static_cast<ssize_t>(item_size));
-        metrics_.update_string_memory(static_cast<ssize_t>(string_mem));
-        metrics_.update_item_count(1);
-    } else {
-        metrics_.update_memory_usage(-static_cast<ssize_t>(item_size));
-        metrics_.update_string_memory(-static_cast<ssize_t>(string_mem));
-        metrics_.update_item_count(-1);
-    }
+size_t LRUCache::calculate_bucket_memory() const {
+    size_t buckets = cache_.bucket_count();
+    return buckets > 1 ? heap_allocation_size(buckets * sizeof(void*)) : 0;
 }
 
-void LRUCache::put_internal(int key, CacheItem value) {
-    size_t new_item_size = calculate_item_memory_size(value);
-
-    auto old_it = cache_.find(key);
-    if (old_it != cache_.end()) {
-        size_t old_size = calculate_item_memory_size(old_it->second.second.item);
-        metrics_.update_memory_usage(-static_cast<ssize_t>(old_size));
-        lru_list_.erase(old_it->second.first);
-        cache_.erase(old_it);
-    }
+void LRUCache::insert_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                            int key, CacheItem value) const {
+    list.push_front(CacheEntry{std::move(value), std::chrono::steady_clock::now()});
+    auto& node = *map.emplace(key, std::make_pair(list.begin(), list.front())).first;
 
-    evict_if_needed();
+    auto& entry = node.second.second;
+    entry.memory_size = calculate_item_memory_size(node);
+    entry.string_memory = calculate_string_memory(node.second.first->item) +
+                          calculate_string_memory(entry.item);
 
-    CacheEntry entry{std::move(value), std::chrono::steady_clock::now()};
-    lru_list_.push_front(entry);
-    cache_[key] = {lru_list_.begin(), entry};
-    metrics_.update_memory_usage(static_cast<ssize_t>(new_item_size));
+    totals.memory += entry.memory_size;
+    totals.string_memory += entry.string_memory;
 }
 
-size_t LRUCache::calculate_actual_memory_usage() const {
-    size_t total = 0;
-    for (const auto& pair : cache_) {
-        total += calculate_item_memory_size(pair.second.second.item);
-    }
-    return total;
-}
+void LRUCache::erase_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                           CacheMap::iterator it) const {
+    const auto& entry = it->second.second;
 
-void LRUCache::validate_metrics() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    totals.memory -= entry.memory_size;
+    totals.string_memory -= entry.string_memory;
 
-    size_t actual_memory = calculate_actual_memory_usage();
-    size_t reported_memory = metrics_.get_memory_usage();
+    list.erase(it->second.first);
+    map.erase(it);
+}
 
-    if (actual_memory != reported_memory) {
-        ssize_t correction = static_cast<ssize_t>(actual_memory) -
-                           static_cast<ssize_t>(reported_memory);
-        metrics_.update_memory_usage(correction);
+void LRUCache::put_entry(CacheMap& map, LruList& list, EntryTotals& totals,
+                         int key, CacheItem value) const {
+    auto old_it = map.find(key);
+    if (old_it != map.end()) {
+        erase_entry(map, list, totals, old_it);
     }
 
-    size_t actual_count = cache_.size();
-    metrics_.update_item_count(
-        static_cast<ssize_t>(actual_count) -
-        static_cast<ssize_t>(metrics_.get_item_count()));
+    evict_if_needed(map, list, totals);
+    insert_entry(map, list, totals, key, std::move(value));
 }
 
-void LRUCache::put(int key, CacheItem value) {
-    auto start = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(mutex_);
+void LRUCache::put_internal(int key, CacheItem value) {
+    put_entry(cache_, lru_list_, totals_, key, std::move(value));
+    sync_metrics();
+}
 
-    auto old_it = cache_.find(key);
-    if (old_it != cache_.end()) {
-        update_metrics_for_item(old_it->second.second.item, false);
-        lru_list_.erase(old_it->second.first);
-        cache_.erase(old_it);
-    }
+void LRUCache::sync_metrics() {
+    size_t memory = totals_.memory + calculate_bucket_memory();
+    metrics_.update_memory_usage(static_cast<ssize_t>(memory) -
+                                 static_cast<ssize_t>(metrics_.get_memory_usage()));
+    metrics_.update_string_memory(static_cast<ssize_t>(totals_.string_memory) -
+                                  static_cast<ssize_t>(metrics_.get_string_memory()));
+    metrics_.update_item_count(static_cast<ssize_t>(cache_.size()) -
+                               static_cast<ssize_t>(metrics_.get_item_count()));
+}
 
-    while (cache_.size() >= capacity_) {
-        if (!lru_list_.empty()) {
-            auto last = std::prev(lru_list_.end());
-            auto it = std::find_if(cache_.begin(), cache_.end(),
-                [&](const auto& pair) { return pair.second.first == last; });
-
-            if (it != cache_.end()) {
-                update_metrics_for_item(it->second.second.item, false);
-                cache_.erase(it);
-            }
-            lru_list_.pop_back();
-        }
-    }
+void LRUCache::validate_metrics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sync_metrics();
+}
 
-    CacheEntry entry{std::move(value), std::chrono::steady_clock::now()};
-    update_metrics_for_item(entry.item, true);
+void LRUCache::put(int key, CacheItem value) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    lru_list_.push_front(entry);
-    cache_[key] = {lru_list_.begin(), entry};
+    put_internal(key, std::move(value));
 
     auto duration = std::chrono::steady_clock::now() - start;
     metrics_.record_write(std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
 }
 
-void LRUCache::evict_if_needed() {
-    while (cache_.size() >= capacity_ && !lru_list_.empty()) {
-        auto last = std::prev(lru_list_.end());
-        auto it = std::find_if(cache_.begin(), cache_.end(),
+void LRUCache::evict_if_needed(CacheMap& map, LruList& list, EntryTotals& totals) const {
+    while (map.size() >= capacity_ && !list.empty()) {
+        auto last = std::prev(list.end());
+        auto it = std::find_if(map.begin(), map.end(),
             [&](const auto& pair) { return pair.second.first == last; });
 
-        if (it != cache_.end()) {
-            size_t item_size = calculate_item_memory_size(it->second.second.item);
-            metrics_.update_memory_usage(-static_cast<ssize_t>(item_size));
-            cache_.erase(it);
+        if (it != map.end()) {
+            erase_entry(map, list, totals, it);
+        } else {
+            list.pop_back();
         }
-        lru_list_.pop_back();
     }
 }
 
@@ -179,10 +180,8 @@ void LRUCache::remove(int key) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = cache_.find(key);
     if (it != cache_.end()) {
-        size_t item_size = calculate_item_memory_size(it->second.second.item);
-        metrics_.update_memory_usage(-static_cast<ssize_t>(item_size));
-        lru_list_.erase(it->second.first);
-        cache_.erase(it);
+        erase_entry(cache_, lru_list_, totals_, it);
+        sync_metrics();
     }
 }
 
@@ -191,12 +190,10 @@ void LRUCache::clear() {
 
     cache_.clear();
     lru_list_.clear();
-
-    metrics_.update_memory_usage(-static_cast<ssize_t>(metrics_.get_memory_usage()));
-    metrics_.update_string_memory(-static_cast<ssize_t>(metrics_.get_string_memory()));
-    metrics_.update_item_count(-static_cast<ssize_t>(metrics_.get_item_count()));
+    totals_ = EntryTotals{};
 
     metrics_.reset_counters();
+    sync_metrics();
 }
 
 size_t LRUCache::size() const {
@@ -212,20 +209,16 @@ void LRUCache::save_to_file(const std::string& filename) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     try {
-        nlohmann::json j = nlohmann::json::array();
-        for (const auto& entry : cache_) {
-            j.push_back({
-                {"key", entry.first},
-                {"value", entry.second.second.item.to_json()}
-            });
-        }
-
         std::ofstream file(filename, std::ios::out | std::ios::trunc);
         if (!file) {
             throw std::runtime_error("Failed to open file for writing: " + filename);
         }
 
-        file << j.dump(4);
+        CacheJsonWriter writer(file);
+        for (const auto& entry : cache_) {
+            writer.write(entry.first, entry.second.second.item);
+        }
+        writer.finish();
         file.close();
 
         if (file.fail()) {
@@ -237,26 +230,29 @@ void LRUCache::save_to_file(const std::string& filename) {
 }
 
 void LRUCache::load_from_file(const std::string& filename) {
-    nlohmann::json j;
-    {
-        std::ifstream file(filename);
-        if (!file) {
-            throw std::runtime_error("Failed to open file for reading: " + filename);
-        }
-        file >> j;
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Failed to open file for reading: " + filename);
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    try {
-        cache_.clear();
-        lru_list_.clear();
+    // Parse into staging containers without holding the lock, so a bad file
+    // leaves the cache untouched and readers are not blocked meanwhile.
+    CacheMap entries;
+    LruList order;
+    EntryTotals totals;
+    entries.reserve(capacity_);
 
-        for (const auto& item : j) {
-            int key = item["key"].get<int>();
-            CacheItem value = CacheItem::from_json(item["value"]);
-            put_internal(key, value);
-        }
+    try {
+        read_cache_json(file, [&](int key, CacheItem&& value) {
+            put_entry(entries, order, totals, key, std::move(value));
+        });
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to load cache: " + std::string(e.what()));
     }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.swap(entries);
+    lru_list_.swap(order);
+    totals_ = totals;
+    sync_metrics();
 }
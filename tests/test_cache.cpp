@@ -1,9 +1,17 @@
 #define CATCH_CONFIG_MAIN
 #include "catch/catch.hpp"
 #include "cache/lru_cache.hpp"
+#include "cache/json_stream.hpp"
 #include <thread>
 #include <atomic>
 #include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 TEST_CASE("Cache basic operations", "[cache]") {
     LRUCache cache(3);
@@ -109,3 +117,185 @@ TEST_CASE("Cache serialization", "[cache]") {
     // Clean up test file
     std::remove(test_file.c_str());
 }
+
+TEST_CASE("Streaming JSON serialization", "[cache][json]") {
+    CacheItem item1{1, "CS", "Algorithms", "Title \"1\"", "Desc1\n", 10, "t.me/group1", 100};
+    CacheItem item2{2, "Math", "Calculus", "Title2", "Desc2", 20, "t.me/group2", 200};
+
+    std::vector<std::pair<int, CacheItem>> entries;
+    auto collect = [&entries](int key, CacheItem&& item) {
+        entries.emplace_back(key, std::move(item));
+    };
+
+    SECTION("Writer output round-trips through the reader") {
+        std::stringstream stream;
+        CacheJsonWriter writer(stream);
+        writer.write(10, item1);
+        writer.write(20, item2);
+        writer.finish();
+
+        REQUIRE_NOTHROW(read_cache_json(stream, collect));
+        REQUIRE(entries.size() == 2);
+        CHECK(entries[0].first == 10);
+        CHECK(entries[0].second.title == "Title \"1\"");
+        CHECK(entries[0].second.description == "Desc1\n");
+        CHECK(entries[1].first == 20);
+        CHECK(entries[1].second.userId == 200);
+    }
+
+    SECTION("Empty cache writes an empty array") {
+        std::stringstream stream;
+        CacheJsonWriter writer(stream);
+        writer.finish();
+
+        CHECK(nlohmann::json::parse(stream.str()) == nlohmann::json::array());
+    }
+
+    SECTION("Reader accepts pretty-printed documents and skips unknown fields") {
+        nlohmann::json doc = nlohmann::json::array();
+        nlohmann::json value = item2.to_json();
+        value["tags"] = {"a", {{"b", 1}}};
+        doc.push_back({{"key", 2}, {"meta", {1, 2}}, {"value", value}});
+
+        std::stringstream stream(doc.dump(4));
+        REQUIRE_NOTHROW(read_cache_json(stream, collect));
+        REQUIRE(entries.size() == 1);
+        CHECK(entries[0].first == 2);
+        CHECK(entries[0].second.faculty == "Math");
+        CHECK(entries[0].second.votesCount == 20);
+    }
+
+    SECTION("Reader rejects malformed entries") {
+        std::stringstream missing_field(R"([{"key": 1, "value": {"id": 1}}])");
+        CHECK_THROWS_AS(read_cache_json(missing_field, collect), std::runtime_error);
+
+        nlohmann::json value = item1.to_json();
+        value["title"] = 5;
+        std::stringstream wrong_type(nlohmann::json::array({{{"key", 1}, {"value", value}}}).dump());
+        CHECK_THROWS_AS(read_cache_json(wrong_type, collect), std::runtime_error);
+
+        std::stringstream truncated(R"([{"key": 1, "value": {)");
+        CHECK_THROWS_AS(read_cache_json(truncated, collect), std::runtime_error);
+
+        std::stringstream not_array(R"({"key": 1})");
+        CHECK_THROWS_AS(read_cache_json(not_array, collect), std::runtime_error);
+    }
+}
+
+TEST_CASE("Memory accounting", "[cache][metrics]") {
+    const std::string test_file = "test_cache_memory.json";
+    LRUCache cache(3);
+    const size_t empty_memory = cache.get_metrics().get_memory_usage();
+
+    CacheItem item1{1, "CS", "Algorithms", "Title1", "Desc1", 10, "t.me/group1", 100};
+    CacheItem item2{2, "Math", "Calculus", "Title2", std::string(200, 'd'), 20, "t.me/group2", 200};
+    CacheItem item3{3, "Physics", "Mechanics", "Title3", std::string(500, 'd'), 30, "t.me/group3", 300};
+    CacheItem item4{4, "Biology", "Genetics", "Title4", "Desc4", 40, "t.me/group4", 400};
+
+    SECTION("Overwrite, evict and remove release what put charged") {
+        cache.put(1, item1);
+        const size_t one_item = cache.get_metrics().get_memory_usage();
+        CHECK(one_item > empty_memory);
+
+        cache.put(1, item3);
+        cache.put(1, item1);
+        CHECK(cache.get_metrics().get_memory_usage() == one_item);
+        CHECK(cache.get_metrics().get_item_count() == 1);
+
+        cache.put(2, item2);
+        cache.put(3, item3);
+        cache.put(4, item4);
+        CHECK(cache.get_metrics().get_item_count() == 3);
+        CHECK(cache.get_metrics().get_string_memory() > 0);
+
+        cache.remove(2);
+        cache.remove(3);
+        cache.remove(4);
+        CHECK(cache.get_metrics().get_memory_usage() == empty_memory);
+        CHECK(cache.get_metrics().get_string_memory() == 0);
+        CHECK(cache.get_metrics().get_item_count() == 0);
+    }
+
+    SECTION("Load and clear reset the accounting") {
+        cache.put(1, item1);
+        cache.put(2, item2);
+        const size_t saved_memory = cache.get_metrics().get_memory_usage();
+        REQUIRE_NOTHROW(cache.save_to_file(test_file));
+
+        cache.put(3, item3);
+        REQUIRE_NOTHROW(cache.load_from_file(test_file));
+        CHECK(cache.get_metrics().get_memory_usage() == saved_memory);
+        CHECK(cache.get_metrics().get_item_count() == 2);
+
+        cache.clear();
+        CHECK(cache.get_metrics().get_memory_usage() == empty_memory);
+        CHECK(cache.get_metrics().get_string_memory() == 0);
+        CHECK(cache.get_metrics().get_item_count() == 0);
+    }
+
+    SECTION("Failed load leaves contents and accounting unchanged") {
+        cache.put(1, item1);
+        REQUIRE_NOTHROW(cache.save_to_file(test_file));
+
+        std::string contents;
+        {
+            std::ifstream in(test_file);
+            contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream out(test_file, std::ios::trunc);
+            out << contents.substr(0, contents.size() / 2);
+        }
+
+        cache.put(2, item2);
+        cache.put(3, item3);
+        const size_t memory = cache.get_metrics().get_memory_usage();
+        const size_t string_memory = cache.get_metrics().get_string_memory();
+
+        CHECK_THROWS_AS(cache.load_from_file(test_file), std::runtime_error);
+        CHECK(cache.size() == 3);
+        CHECK(cache.get_metrics().get_memory_usage() == memory);
+        CHECK(cache.get_metrics().get_string_memory() == string_memory);
+        CHECK(cache.get_metrics().get_item_count() == 3);
+        CHECK(cache.get(1));
+        CHECK(cache.get(2));
+        CHECK(cache.get(3));
+    }
+
+    std::remove(test_file.c_str());
+}
+
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+TEST_CASE("Memory accounting matches malloc statistics", "[cache][metrics]") {
+    const size_t item_count = 2000;
+
+    std::vector<CacheItem> items;
+    items.reserve(item_count);
+    for (size_t i = 0; i < item_count; ++i) {
+        int id = static_cast<int>(i);
+        items.push_back({id, "Faculty_" + std::to_string(i % 5), "Course",
+                         "Title_" + std::to_string(i),
+                         std::string(20 + i % 300, 'd'), 0,
+                         "t.me/group_" + std::to_string(i), 1000 + id});
+    }
+
+    malloc_trim(0);
+    const size_t before = mallinfo2().uordblks + mallinfo2().hblkhd;
+    {
+        LRUCache cache(item_count);
+        for (size_t i = 0; i < item_count; ++i) {
+            cache.put(static_cast<int>(i), items[i]);
+        }
+
+        malloc_trim(0);
+        const size_t allocated = mallinfo2().uordblks + mallinfo2().hblkhd - before;
+        const size_t reported = cache.get_metrics().get_memory_usage();
+
+        INFO("malloc: " << allocated << " bytes, metrics: " << reported << " bytes");
+        CHECK(reported <= allocated);
+        CHECK(reported >= allocated - allocated / 50);
+    }
+}
+#endif
+#endif